@@ -0,0 +1,674 @@
+/*****************************************************************
+  File:             BM22S4221-1_Linux.cpp
+  Author:           BESTMODULES
+  Description:      Linux host backend: termios serial ports driven by one
+                    epoll thread, for gateways with many USB-UART modules
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_Linux.h"
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <string.h>
+#include  <termios.h>
+#include  <time.h>
+#include  <unistd.h>
+#include  <sys/epoll.h>
+#include  <sys/eventfd.h>
+
+#define  WAKE_ID  0xFFFFFFFFu  // epoll data of the eventfd
+
+/**********************************************************
+Description: Create a closed port
+Parameters:  none
+Return:      none
+Others:
+**********************************************************/
+BM22S4221_1_Port::BM22S4221_1_Port()
+{
+  _fd = -1;
+  _recLen = 0;
+}
+BM22S4221_1_Port::~BM22S4221_1_Port()
+{
+  end();
+}
+/**********************************************************
+Description: Open a serial device at 9600 8N1, raw and non-blocking
+Parameters:  path: device path, e.g. /dev/ttyUSB0
+Return:      0: opened successfully
+             -1: open or termios setup failed, see errno
+Others:
+**********************************************************/
+int BM22S4221_1_Port::begin(const char *path)
+{
+  struct termios tio;
+
+  end();
+  _fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (_fd < 0)
+  {
+    return -1;
+  }
+  if (tcgetattr(_fd, &tio) != 0)
+  {
+    end();
+    return -1;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  tio.c_cflag |= CS8 | CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, B9600);
+  cfsetospeed(&tio, B9600);
+  if (tcsetattr(_fd, TCSANOW, &tio) != 0)
+  {
+    end();
+    return -1;
+  }
+  tcflush(_fd, TCIOFLUSH);
+  _recLen = 0;
+  return 0;
+}
+/**********************************************************
+Description: Close the serial device
+Parameters:  none
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Port::end()
+{
+  if (_fd >= 0)
+  {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
+/**********************************************************
+Description: Get the file descriptor of the serial device
+Parameters:  none
+Return:      fd, -1 when closed
+Others:
+**********************************************************/
+int BM22S4221_1_Port::getFd()
+{
+  return _fd;
+}
+/**********************************************************
+Description: Write without blocking
+Parameters:  wbuf:data to send
+             len:data length
+Return:      bytes written, 0 when the device buffer is full, -1 on error
+Others:
+**********************************************************/
+int BM22S4221_1_Port::write(const uint8_t wbuf[], uint8_t len)
+{
+  ssize_t num = ::write(_fd, wbuf, len);
+  if (num < 0)
+  {
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+  }
+  return (int)num;
+}
+/**********************************************************
+Description: Feed one received byte into the frame parser
+             Frames start with FRAME_HEADER, the frame length and the
+             fixed bytes FRAME_ID0 FRAME_ID1; the last byte is the check
+             code. Bytes outside a frame are dropped.
+Parameters:  data: received byte
+             frames: complete frames with a correct check code are appended
+Return:      number of frames appended
+Others:      The port field of the frames is left to the caller
+**********************************************************/
+uint8_t BM22S4221_1_Port::parse(uint8_t data, std::vector<BM22S4221_1_Frame> &frames)
+{
+  BM22S4221_1_Frame frame;
+  uint8_t len;
+
+  if (_recLen == 0 && data != FRAME_HEADER)
+  {
+    return 0;
+  }
+  _recBuf[_recLen++] = data;
+  if ((_recLen == 2 && (data < 5 || data > FRAME_MAX_LEN)) ||
+      (_recLen == 3 && data != FRAME_ID0) ||
+      (_recLen == 4 && data != FRAME_ID1))
+  {
+    return resync(frames); // False header, the length is not trusted
+  }
+  if (_recLen < 4)
+  {
+    return 0;
+  }
+  len = _recBuf[1];
+  if (_recLen < len)
+  {
+    return 0;
+  }
+  if (BM22S4221_1_checkCode(_recBuf, len - 1) != _recBuf[len - 1])
+  {
+    return resync(frames);
+  }
+  _recLen = 0;
+  frame.port = -1;
+  frame.status = CHECK_OK;
+  frame.cmd = _recBuf[4];
+  frame.len = len;
+  memcpy(frame.data, _recBuf, len);
+  frames.push_back(frame);
+  return 1;
+}
+/**********************************************************
+Description: Drop a false frame header and parse the bytes after it again
+Parameters:  frames: frames found in those bytes are appended
+Return:      number of frames appended
+Others:
+**********************************************************/
+uint8_t BM22S4221_1_Port::resync(std::vector<BM22S4221_1_Frame> &frames)
+{
+  uint8_t rest[FRAME_MAX_LEN];
+  uint8_t len = _recLen - 1;
+  uint8_t num = 0;
+
+  memcpy(rest, _recBuf + 1, len);
+  _recLen = 0;
+  for (uint8_t i = 0; i < len; i++)
+  {
+    num += parse(rest[i], frames);
+  }
+  return num;
+}
+
+/**********************************************************
+Description: Create an empty gateway
+Parameters:  none
+Return:      none
+Others:
+**********************************************************/
+BM22S4221_1_Gateway::BM22S4221_1_Gateway()
+{
+  _running = false;
+  _epfd = -1;
+  _evfd = -1;
+}
+BM22S4221_1_Gateway::~BM22S4221_1_Gateway()
+{
+  end();
+  for (size_t i = 0; i < _channels.size(); i++)
+  {
+    delete _channels[i];
+  }
+}
+/**********************************************************
+Description: Open a module port
+Parameters:  path: device path, e.g. /dev/ttyUSB0
+Return:      port id passed to submit() and reported in frames
+             -1: open failed or the gateway is already running
+Others:      Call before begin()
+**********************************************************/
+int BM22S4221_1_Gateway::addPort(const char *path)
+{
+  if (_running)
+  {
+    return -1;
+  }
+  Channel *ch = new Channel();
+  if (ch->port.begin(path) != 0)
+  {
+    delete ch;
+    return -1;
+  }
+  ch->queued = false;
+  ch->busy = false;
+  ch->failed = false;
+  ch->cmd = 0;
+  ch->addr = 0;
+  ch->seq = 0;
+  ch->txLen = 0;
+  ch->txWait = false;
+  _channels.push_back(ch);
+  return (int)_channels.size() - 1;
+}
+/**********************************************************
+Description: Get the number of ports
+Parameters:  none
+Return:      port count
+Others:
+**********************************************************/
+size_t BM22S4221_1_Gateway::getPortNum()
+{
+  return _channels.size();
+}
+/**********************************************************
+Description: Set the frame handler
+             Frames from all ports collected in one loop pass are
+             delivered in a single call, on the gateway thread.
+Parameters:  handler: frame handler
+Return:      none
+Others:      Call before begin()
+**********************************************************/
+void BM22S4221_1_Gateway::onFrames(BM22S4221_1_FrameHandler handler)
+{
+  _handler = handler;
+}
+/**********************************************************
+Description: Start the event loop thread
+Parameters:  none
+Return:      0: started successfully
+             -1: epoll or eventfd setup failed
+Others:
+**********************************************************/
+int BM22S4221_1_Gateway::begin()
+{
+  struct epoll_event ev;
+  int epfd, evfd;
+  size_t i;
+
+  if (_running)
+  {
+    return 0;
+  }
+  epfd = epoll_create1(EPOLL_CLOEXEC);
+  evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.u32 = WAKE_ID;
+  bool ok = (epfd >= 0 && evfd >= 0 && epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &ev) == 0);
+  for (i = 0; ok && i < _channels.size(); i++)
+  {
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)i;
+    _channels[i]->txWait = false;
+    ok = (epoll_ctl(epfd, EPOLL_CTL_ADD, _channels[i]->port.getFd(), &ev) == 0);
+  }
+  if (!ok)
+  {
+    if (epfd >= 0)
+    {
+      ::close(epfd);
+    }
+    if (evfd >= 0)
+    {
+      ::close(evfd);
+    }
+    return -1;
+  }
+  _epfd = epfd;
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _evfd = evfd;
+    wake(); // Commands submitted while stopped sit in _ready without a wakeup
+  }
+  _running = true;
+  _thread = std::thread(&BM22S4221_1_Gateway::run, this);
+  return 0;
+}
+/**********************************************************
+Description: Stop the event loop thread
+Parameters:  none
+Return:      none
+Others:      Ports stay open, commands still queued are kept
+**********************************************************/
+void BM22S4221_1_Gateway::end()
+{
+  if (_running)
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _running = false;
+    wake();
+  }
+  if (_thread.joinable())
+  {
+    _thread.join();
+  }
+  {
+    /* submit() writes _evfd under _lock, so it never sees a closed descriptor */
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_evfd >= 0)
+    {
+      ::close(_evfd);
+      _evfd = -1;
+    }
+  }
+  if (_epfd >= 0)
+  {
+    ::close(_epfd);
+    _epfd = -1;
+  }
+}
+/**********************************************************
+Description: Queue a command for a port without blocking
+             Commands of one port are sent one at a time, the next is
+             sent when the ack arrives or after ACK_TIMEOUT_MS.
+Parameters:  port: port id
+             cmd:command code
+             addr:register address
+             data:register data
+Return:      0: queued successfully
+             -1: unknown port
+Others:      Safe to call from any thread, also while begin() or end() runs
+**********************************************************/
+int BM22S4221_1_Gateway::submit(int port, uint8_t cmd, uint8_t addr, uint8_t data)
+{
+  if (port < 0 || (size_t)port >= _channels.size())
+  {
+    return -1;
+  }
+  Channel *ch = _channels[port];
+  Command c = {cmd, addr, data};
+  std::lock_guard<std::mutex> guard(_lock);
+
+  ch->queue.push_back(c);
+  if (!ch->queued)
+  {
+    ch->queued = true;
+    if (_ready.empty())
+    {
+      wake();
+    }
+    _ready.push_back(port);
+  }
+  return 0;
+}
+/**********************************************************
+Description: Wake the event loop
+Parameters:  none
+Return:      none
+Others:      Call with _lock held; does nothing while stopped
+**********************************************************/
+void BM22S4221_1_Gateway::wake()
+{
+  uint64_t one = 1;
+  if (_evfd >= 0 && ::write(_evfd, &one, sizeof(one)) < 0)
+  {
+    /* Counter already non-zero, the loop is woken anyway */
+  }
+}
+/**********************************************************
+Description: Queue an info package request, see BM22S4221_1::requestInfoPackage()
+Parameters:  port: port id
+Return:      0: queued successfully
+             -1: unknown port
+Others:      Check the frame with BM22S4221_1_checkFrame(data, INFO_PACKAGE_LEN, CMD_U0)
+**********************************************************/
+int BM22S4221_1_Gateway::requestInfoPackage(int port)
+{
+  return submit(port, CMD_U0, 0x00, 0x00);
+}
+/**********************************************************
+Description: Queue a VBG query, see BM22S4221_1::getVBG()
+Parameters:  port: port id
+Return:      0: queued successfully
+             -1: unknown port
+Others:      Convert data[6] of the ack with BM22S4221_1_vbgToMv()
+**********************************************************/
+int BM22S4221_1_Gateway::requestVBG(int port)
+{
+  return submit(port, CMD_R2, ADD_R0, 0x00);
+}
+/**********************************************************
+Description: Queue a register read, see BM22S4221_1::readRegister()
+Parameters:  port: port id
+             addr: register address, ADD_W0~ADD_W6
+Return:      0: queued successfully
+             -1: unknown port
+Others:      The ack carries the address in data[5] and the value in data[6]
+**********************************************************/
+int BM22S4221_1_Gateway::readRegister(int port, uint8_t addr)
+{
+  return submit(port, CMD_R0, addr, 0x00);
+}
+/**********************************************************
+Description: Queue a register write, see BM22S4221_1::writeRegister()
+Parameters:  port: port id
+             addr: register address, ADD_W0~ADD_W6
+             value: raw register value
+Return:      0: queued successfully
+             -1: unknown port
+Others:
+**********************************************************/
+int BM22S4221_1_Gateway::writeRegister(int port, uint8_t addr, uint8_t value)
+{
+  return submit(port, CMD_W, addr, value);
+}
+/**********************************************************
+Description: Event loop, runs on the gateway thread
+Parameters:  none
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Gateway::run()
+{
+  struct epoll_event events[GATEWAY_MAX_EVENTS];
+  std::vector<BM22S4221_1_Frame> frames;
+  std::vector<int> ready;
+  uint64_t now, count;
+  int num, timeout, i;
+
+  while (_running)
+  {
+    timeout = -1;
+    if (!_deadlines.empty())
+    {
+      now = nowMs();
+      timeout = (_deadlines.top().time > now) ? (int)(_deadlines.top().time - now) : 0;
+    }
+    num = epoll_wait(_epfd, events, GATEWAY_MAX_EVENTS, timeout);
+    if (num < 0 && errno != EINTR)
+    {
+      break;
+    }
+    frames.clear();
+    for (i = 0; i < num; i++)
+    {
+      uint32_t id = events[i].data.u32;
+      if (id == WAKE_ID)
+      {
+        if (::read(_evfd, &count, sizeof(count)) < 0)
+        {
+          /* Nothing to drain */
+        }
+        {
+          std::lock_guard<std::mutex> guard(_lock);
+          ready.swap(_ready);
+          for (size_t j = 0; j < ready.size(); j++)
+          {
+            _channels[ready[j]]->queued = false;
+          }
+        }
+        for (size_t j = 0; j < ready.size(); j++)
+        {
+          startNext(ready[j]);
+        }
+        ready.clear();
+        continue;
+      }
+      if (events[i].events & EPOLLIN)
+      {
+        receive(id, frames);
+      }
+      if (events[i].events & EPOLLOUT)
+      {
+        transmit(id);
+      }
+      if (events[i].events & (EPOLLERR | EPOLLHUP))
+      {
+        /* Adapter unplugged: stop watching it, pending commands time out */
+        _channels[id]->failed = true;
+        epoll_ctl(_epfd, EPOLL_CTL_DEL, _channels[id]->port.getFd(), NULL);
+      }
+    }
+    expire(nowMs(), frames);
+    if (!frames.empty() && _handler)
+    {
+      _handler(frames.data(), frames.size());
+    }
+  }
+}
+/**********************************************************
+Description: Read and parse everything the port has received
+Parameters:  id: port id
+             frames: complete frames are appended here
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Gateway::receive(int id, std::vector<BM22S4221_1_Frame> &frames)
+{
+  Channel *ch = _channels[id];
+  uint8_t rbuf[256];
+  ssize_t num;
+  size_t first;
+
+  while ((num = ::read(ch->port.getFd(), rbuf, sizeof(rbuf))) > 0)
+  {
+    for (ssize_t i = 0; i < num; i++)
+    {
+      first = frames.size();
+      if (ch->port.parse(rbuf[i], frames) == 0)
+      {
+        continue;
+      }
+      for (size_t j = first; j < frames.size(); j++)
+      {
+        frames[j].port = id;
+        if (ch->busy && isAckOf(frames[j], ch))
+        {
+          ch->busy = false;
+          startNext(id);
+        }
+      }
+    }
+  }
+}
+/**********************************************************
+Description: Send the rest of a command frame once the port is writable
+Parameters:  id: port id
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Gateway::transmit(int id)
+{
+  Channel *ch = _channels[id];
+  struct epoll_event ev;
+  int num;
+
+  num = (ch->txLen > 0) ? ch->port.write(ch->tx + 4 - ch->txLen, ch->txLen) : 0;
+  if (num > 0)
+  {
+    ch->txLen -= num;
+  }
+  if (num < 0)
+  {
+    ch->txLen = 0; // Write error, the command will time out
+  }
+  if (ch->txWait != (ch->txLen > 0))
+  {
+    ch->txWait = (ch->txLen > 0);
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ch->txWait ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u32 = (uint32_t)id;
+    epoll_ctl(_epfd, EPOLL_CTL_MOD, ch->port.getFd(), &ev);
+  }
+}
+/**********************************************************
+Description: Send the next queued command of a port if it is free
+Parameters:  id: port id
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Gateway::startNext(int id)
+{
+  Channel *ch = _channels[id];
+  Command c;
+
+  if (ch->busy)
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (ch->queue.empty())
+    {
+      return;
+    }
+    c = ch->queue.front();
+    ch->queue.pop_front();
+  }
+  BM22S4221_1_buildCommand(ch->tx, c.cmd, c.addr, c.data);
+  ch->txLen = 4;
+  ch->busy = true;
+  ch->cmd = c.cmd;
+  ch->addr = c.addr;
+  ch->seq++;
+  Deadline d = {nowMs() + ACK_TIMEOUT_MS, id, ch->seq};
+  _deadlines.push(d);
+  if (!ch->failed)
+  {
+    transmit(id);
+  }
+}
+/**********************************************************
+Description: Report commands whose ack did not arrive in time
+Parameters:  now: current time, unit ms
+             frames: timeout frames are appended here
+Return:      none
+Others:      Deadlines of acked commands are dropped lazily
+**********************************************************/
+void BM22S4221_1_Gateway::expire(uint64_t now, std::vector<BM22S4221_1_Frame> &frames)
+{
+  while (!_deadlines.empty() && _deadlines.top().time <= now)
+  {
+    Deadline d = _deadlines.top();
+    Channel *ch = _channels[d.port];
+    _deadlines.pop();
+    if (!ch->busy || ch->seq != d.seq)
+    {
+      continue;
+    }
+    BM22S4221_1_Frame frame;
+    frame.port = d.port;
+    frame.status = TIMEOUT_ERROR;
+    frame.cmd = ch->cmd;
+    frame.len = 0;
+    frames.push_back(frame);
+    ch->busy = false;
+    ch->txLen = 0;
+    startNext(d.port);
+  }
+}
+/**********************************************************
+Description: Query whether a frame is the ack of the pending command
+             Register and VBG acks must also carry the command's address,
+             so a late ack of a timed out command can't complete the
+             next one.
+Parameters:  frame: received frame
+             ch: channel with a pending command
+Return:      true: frame acks the pending command
+             false: unrelated frame
+Others:
+**********************************************************/
+bool BM22S4221_1_Gateway::isAckOf(const BM22S4221_1_Frame &frame, const Channel *ch)
+{
+  if (frame.cmd != ch->cmd)
+  {
+    return false;
+  }
+  if (ch->cmd == CMD_R0 || ch->cmd == CMD_R2 || ch->cmd == CMD_W)
+  {
+    return frame.data[5] == ch->addr;
+  }
+  return true;
+}
+/**********************************************************
+Description: Monotonic clock
+Parameters:  none
+Return:      time, unit ms
+Others:
+**********************************************************/
+uint64_t BM22S4221_1_Gateway::nowMs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,121 @@
+/*****************************************************************
+File:             BM22S4221-1_Linux.h
+Author:           BESTMODULES
+Description:      Linux host backend: termios serial ports driven by one
+                  epoll thread, for gateways with many USB-UART modules
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _BM22S4221_Linux_h_
+#define  _BM22S4221_Linux_h_
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "BM22S4221-1_Protocol.h"
+#define  GATEWAY_MAX_EVENTS  64
+
+typedef struct
+{
+  int port;                     // Port id returned by addPort()
+  uint8_t status;               // CHECK_OK: frame received, TIMEOUT_ERROR: command got no ack
+  uint8_t cmd;                  // Command code of the frame
+  uint8_t len;                  // Frame length, 0 on timeout
+  uint8_t data[FRAME_MAX_LEN];  // Frame data
+} BM22S4221_1_Frame;
+
+/* Receives every frame collected in one pass of the event loop */
+typedef std::function<void(const BM22S4221_1_Frame frames[], size_t num)> BM22S4221_1_FrameHandler;
+
+
+ class BM22S4221_1_Port
+ {
+    public:
+    BM22S4221_1_Port();
+    ~BM22S4221_1_Port();
+    int begin(const char *path);
+    void end();
+    int getFd();
+    int write(const uint8_t wbuf[], uint8_t len);
+    uint8_t parse(uint8_t data, std::vector<BM22S4221_1_Frame> &frames);
+
+    private:
+    uint8_t resync(std::vector<BM22S4221_1_Frame> &frames);
+    int _fd;
+    uint8_t _recBuf[FRAME_MAX_LEN];  // Frame being received
+    uint8_t _recLen;
+ };
+
+
+ class BM22S4221_1_Gateway
+ {
+    public:
+    BM22S4221_1_Gateway();
+    ~BM22S4221_1_Gateway();
+    int addPort(const char *path);
+    size_t getPortNum();
+    void onFrames(BM22S4221_1_FrameHandler handler);
+    int begin();
+    void end();
+    int submit(int port, uint8_t cmd, uint8_t addr, uint8_t data);
+    int requestInfoPackage(int port);
+    int requestVBG(int port);
+    int readRegister(int port, uint8_t addr);
+    int writeRegister(int port, uint8_t addr, uint8_t value);
+
+    private:
+    struct Command
+    {
+      uint8_t cmd;
+      uint8_t addr;
+      uint8_t data;
+    };
+    struct Channel
+    {
+      BM22S4221_1_Port port;
+      std::deque<Command> queue;   // Commands waiting, guarded by _lock
+      bool queued;                 // Channel is in _ready, guarded by _lock
+      bool busy;                   // A command is waiting for its ack
+      bool failed;                 // Port hung up
+      uint8_t cmd;                 // Command waiting for its ack
+      uint8_t addr;                // Its register address
+      uint32_t seq;                // Sequence number of that command
+      uint8_t tx[4];               // Unsent part of the command frame
+      uint8_t txLen;
+      bool txWait;                 // EPOLLOUT is armed for the unsent part
+    };
+    struct Deadline
+    {
+      uint64_t time;
+      int port;
+      uint32_t seq;
+      bool operator>(const Deadline &other) const { return time > other.time; }
+    };
+    void run();
+    void receive(int id, std::vector<BM22S4221_1_Frame> &frames);
+    void transmit(int id);
+    void startNext(int id);
+    void expire(uint64_t now, std::vector<BM22S4221_1_Frame> &frames);
+    void wake();
+    static bool isAckOf(const BM22S4221_1_Frame &frame, const Channel *ch);
+    static uint64_t nowMs();
+    std::vector<Channel *> _channels;
+    BM22S4221_1_FrameHandler _handler;
+    std::mutex _lock;
+    std::vector<int> _ready;       // Channels with new commands, guarded by _lock
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > _deadlines;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    int _epfd;
+    int _evfd;                     // eventfd that wakes the loop on submit(), guarded by _lock
+ };
+
+
+ 
+#endif
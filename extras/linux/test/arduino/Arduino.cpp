@@ -0,0 +1,71 @@
+/*****************************************************************
+  File:             Arduino.cpp
+  Author:           BESTMODULES
+  Description:      Minimal Arduino core stub so the library logic can be
+                    tested on a Linux host
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "Arduino.h"
+#include  <deque>
+
+unsigned long stubTime = 0;
+int stubPinLevel = LOW;
+void (*stubOnWrite)(const uint8_t wbuf[], size_t len) = NULL;
+static std::deque<uint8_t> rxFifo;
+
+unsigned long millis()
+{
+  return stubTime;
+}
+void delay(unsigned long ms)
+{
+  stubTime += ms;
+}
+int digitalRead(uint8_t pin)
+{
+  (void)pin;
+  return stubPinLevel;
+}
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void)pin;
+  (void)mode;
+}
+void HardwareSerial::begin(unsigned long baud)
+{
+  (void)baud;
+}
+int HardwareSerial::available()
+{
+  return (int)rxFifo.size();
+}
+int HardwareSerial::read()
+{
+  if (rxFifo.empty())
+  {
+    return -1;
+  }
+  int data = rxFifo.front();
+  rxFifo.pop_front();
+  return data;
+}
+size_t HardwareSerial::write(const uint8_t wbuf[], size_t len)
+{
+  if (stubOnWrite != NULL)
+  {
+    stubOnWrite(wbuf, len);
+  }
+  return len;
+}
+void stubReceive(const uint8_t rbuf[], size_t len)
+{
+  rxFifo.insert(rxFifo.end(), rbuf, rbuf + len);
+}
+void stubReset()
+{
+  stubTime = 0;
+  stubPinLevel = LOW;
+  stubOnWrite = NULL;
+  rxFifo.clear();
+}
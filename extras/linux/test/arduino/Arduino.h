@@ -0,0 +1,41 @@
+/*****************************************************************
+File:             Arduino.h
+Author:           BESTMODULES
+Description:      Minimal Arduino core stub so the library logic can be
+                  tested on a Linux host
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _Arduino_stub_h_
+#define  _Arduino_stub_h_
+#include <stddef.h>
+#include <stdint.h>
+#define  HIGH    1
+#define  LOW     0
+#define  INPUT   0
+#define  OUTPUT  1
+#define  lowByte(w) ((uint8_t)((w) & 0xff))
+
+unsigned long millis();
+void delay(unsigned long ms);
+int digitalRead(uint8_t pin);
+void pinMode(uint8_t pin, uint8_t mode);
+
+ class HardwareSerial
+ {
+    public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    size_t write(const uint8_t wbuf[], size_t len);
+ };
+
+/* Test hooks */
+extern unsigned long stubTime;                 // Value of millis(), delay() advances it
+extern int stubPinLevel;                       // Value of digitalRead()
+extern void (*stubOnWrite)(const uint8_t wbuf[], size_t len); // Called for every serial write
+void stubReceive(const uint8_t rbuf[], size_t len);          // Queue bytes for read()
+void stubReset();
+
+#endif
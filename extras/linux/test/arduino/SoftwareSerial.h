@@ -0,0 +1,19 @@
+/*****************************************************************
+File:             SoftwareSerial.h
+Author:           BESTMODULES
+Description:      SoftwareSerial stub for host tests
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _SoftwareSerial_stub_h_
+#define  _SoftwareSerial_stub_h_
+#include "Arduino.h"
+
+ class SoftwareSerial : public HardwareSerial
+ {
+    public:
+    SoftwareSerial(uint8_t rxPin, uint8_t txPin) { (void)rxPin; (void)txPin; }
+ };
+
+#endif
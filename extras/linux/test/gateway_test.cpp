@@ -0,0 +1,353 @@
+/*****************************************************************
+  File:             gateway_test.cpp
+  Author:           BESTMODULES
+  Description:      Drives BM22S4221_1_Gateway against emulated modules
+                    on pseudo-terminal pairs
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_Linux.h"
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <unistd.h>
+#include  <sys/epoll.h>
+#include  <sys/resource.h>
+#include  <chrono>
+#include  <condition_variable>
+
+#define  SENSOR_NUM  200
+
+/* Emulated module: answers commands on the master side of a pty */
+struct Emulator
+{
+  int fd;
+  bool mute;                      // Never answer, to provoke timeouts
+  bool noise;                     // Send garbage before every ack
+  bool stray;                     // Send a stray header and length before every ack
+  std::atomic<bool> late;         // Answer every command with the ack of the one before, set while running
+  uint8_t lastAck[FRAME_MAX_LEN];
+  uint8_t lastLen;
+  uint8_t cmdBuf[4];
+  uint8_t cmdLen;
+  uint8_t reg[256];
+};
+
+static Emulator emu[SENSOR_NUM];
+static std::atomic<bool> emuRunning(true);
+
+static void emuSend(Emulator &e, const uint8_t *buf, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t num = write(e.fd, buf, len);
+    if (num <= 0)
+    {
+      continue;
+    }
+    buf += num;
+    len -= num;
+  }
+}
+
+static void emuAnswer(Emulator &e)
+{
+  uint8_t ack[FRAME_MAX_LEN] = {FRAME_HEADER, 8, 0x31, 0x01, e.cmdBuf[0], e.cmdBuf[1], 0x00, 0x00};
+  uint8_t len = 8;
+
+  switch (e.cmdBuf[0])
+  {
+    case CMD_R0:
+      ack[6] = e.reg[e.cmdBuf[1]];
+      break;
+    case CMD_R2:
+      ack[6] = 97; // 3.3V supply
+      break;
+    case CMD_W:
+      e.reg[e.cmdBuf[1]] = e.cmdBuf[2];
+      ack[6] = e.cmdBuf[2];
+      break;
+    case CMD_U0:
+      len = 25;
+      ack[1] = len;
+      ack[5] = 0x00;
+      for (uint8_t i = 6; i < 24; i++)
+      {
+        ack[i] = i;
+      }
+      break;
+    default:
+      return;
+  }
+  ack[len - 1] = BM22S4221_1_checkCode(ack, len - 1);
+  if (e.noise)
+  {
+    const uint8_t garbage[] = {0x00, FRAME_HEADER, 0x03, 0x55, FRAME_HEADER, 0x08, 0x31};
+    emuSend(e, garbage, sizeof(garbage));
+  }
+  if (e.stray)
+  {
+    const uint8_t header[] = {FRAME_HEADER, INFO_PACKAGE_LEN};
+    emuSend(e, header, sizeof(header));
+  }
+  if (e.late)
+  {
+    emuSend(e, e.lastAck, e.lastLen);
+    memcpy(e.lastAck, ack, len);
+    e.lastLen = len;
+    return;
+  }
+  emuSend(e, ack, len);
+}
+
+static void emuRun()
+{
+  int epfd = epoll_create1(0);
+  struct epoll_event ev, events[64];
+
+  for (int i = 0; i < SENSOR_NUM; i++)
+  {
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, emu[i].fd, &ev);
+  }
+  while (emuRunning)
+  {
+    int num = epoll_wait(epfd, events, 64, 50);
+    for (int n = 0; n < num; n++)
+    {
+      Emulator &e = emu[events[n].data.u32];
+      uint8_t buf[64];
+      ssize_t len;
+      while ((len = read(e.fd, buf, sizeof(buf))) > 0)
+      {
+        for (ssize_t i = 0; i < len; i++)
+        {
+          e.cmdBuf[e.cmdLen++] = buf[i];
+          if (e.cmdLen < 4)
+          {
+            continue;
+          }
+          e.cmdLen = 0;
+          if (!e.mute && BM22S4221_1_checkCode(e.cmdBuf, 3) == e.cmdBuf[3])
+          {
+            emuAnswer(e);
+          }
+        }
+      }
+    }
+  }
+  close(epfd);
+}
+
+static int openEmulator(Emulator &e, char path[], size_t size)
+{
+  e.fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (e.fd < 0 || grantpt(e.fd) != 0 || unlockpt(e.fd) != 0 || ptsname_r(e.fd, path, size) != 0)
+  {
+    return -1;
+  }
+  fcntl(e.fd, F_SETFL, fcntl(e.fd, F_GETFL) | O_NONBLOCK);
+  e.mute = false;
+  e.noise = false;
+  e.stray = false;
+  e.late = false;
+  e.lastLen = 0;
+  e.cmdLen = 0;
+  memset(e.reg, 0, sizeof(e.reg));
+  e.reg[ADD_W0] = 31;
+  e.reg[ADD_W1] = 15;
+  e.reg[ADD_W2] = 6;
+  e.reg[ADD_W3] = 6;
+  e.reg[ADD_W4] = 60;
+  e.reg[ADD_W5] = PASSIVE;
+  e.reg[ADD_W6] = HIGH_LEVEL;
+  return 0;
+}
+
+/* Collects frames delivered by the gateway thread */
+static std::mutex frameLock;
+static std::condition_variable frameCond;
+static std::vector<BM22S4221_1_Frame> received;
+static size_t batches = 0;
+
+static bool waitFrames(size_t num, int timeoutMs)
+{
+  std::unique_lock<std::mutex> guard(frameLock);
+  return frameCond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                            [num] { return received.size() >= num; });
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+  {
+    failures++;
+  }
+}
+
+/* A stray header and length must not swallow the acks behind it */
+static void testParser()
+{
+  BM22S4221_1_Port port;
+  std::vector<BM22S4221_1_Frame> frames;
+  uint8_t stream[2 + 3 * 8] = {FRAME_HEADER, INFO_PACKAGE_LEN};
+  size_t i;
+
+  for (i = 0; i < 3; i++)
+  {
+    uint8_t *ack = stream + 2 + i * 8;
+    ack[0] = FRAME_HEADER;
+    ack[1] = 8;
+    ack[2] = FRAME_ID0;
+    ack[3] = FRAME_ID1;
+    ack[4] = CMD_R0;
+    ack[5] = BM22S4221_1_configAddr[i];
+    ack[6] = (uint8_t)i;
+    ack[7] = BM22S4221_1_checkCode(ack, 7);
+  }
+  for (i = 0; i < sizeof(stream); i++)
+  {
+    port.parse(stream[i], frames);
+  }
+  check(frames.size() == 3 && frames[0].data[5] == ADD_W0 && frames[2].data[5] == ADD_W2,
+        "parser recovers every ack after a stray AA 19");
+}
+
+int main()
+{
+  BM22S4221_1_Gateway gateway;
+  char path[64];
+  struct rlimit lim;
+
+  /* Each sensor needs two descriptors */
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < 4 * SENSOR_NUM)
+  {
+    lim.rlim_cur = (lim.rlim_max < 4 * SENSOR_NUM) ? lim.rlim_max : 4 * SENSOR_NUM;
+    setrlimit(RLIMIT_NOFILE, &lim);
+  }
+  for (int i = 0; i < SENSOR_NUM; i++)
+  {
+    if (openEmulator(emu[i], path, sizeof(path)) != 0 || gateway.addPort(path) != i)
+    {
+      printf("FAIL: open pty pair %d: %s\n", i, strerror(errno));
+      return 1;
+    }
+  }
+  testParser();
+  emu[1].noise = true;
+  emu[2].mute = true;
+  emu[3].stray = true;
+  gateway.onFrames([](const BM22S4221_1_Frame frames[], size_t num)
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    received.insert(received.end(), frames, frames + num);
+    batches++;
+    frameCond.notify_all();
+  });
+  std::thread emuThread(emuRun);
+
+  /* Commands submitted before begin() are sent once the loop runs */
+  gateway.requestVBG(0);
+  check(gateway.begin() == 0, "gateway starts");
+  check(waitFrames(1, 1000), "command submitted before begin() completes");
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    check(received.size() == 1 && BM22S4221_1_checkFrame(received[0].data, 8, CMD_R2) == CHECK_OK &&
+          BM22S4221_1_vbgToMv(received[0].data[6]) == 3299, "VBG ack decodes to 3299 mV");
+    received.clear();
+  }
+
+  /* One register read on every port */
+  clock_t cpu = clock();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SENSOR_NUM; i++)
+  {
+    gateway.readRegister(i, ADD_W1);
+  }
+  check(waitFrames(SENSOR_NUM, 2000), "every port answers or times out");
+  auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    int ok = 0, timeout = 0;
+    for (size_t i = 0; i < received.size(); i++)
+    {
+      if (received[i].status == CHECK_OK && BM22S4221_1_checkFrame(received[i].data, 8, CMD_R0) == CHECK_OK &&
+          received[i].data[5] == ADD_W1 && received[i].data[6] == 15)
+      {
+        ok++;
+      }
+      if (received[i].status == TIMEOUT_ERROR && received[i].port == 2)
+      {
+        timeout++;
+      }
+    }
+    check(ok == SENSOR_NUM - 1, "register read on all live ports, noisy and stray header ports resync");
+    check(timeout == 1, "muted port reports a timeout");
+    printf("     %d frames in %zu batches, %lld ms wall, %.1f ms cpu\n", (int)received.size(), batches,
+           (long long)wall.count(), (clock() - cpu) * 1000.0 / CLOCKS_PER_SEC);
+    received.clear();
+  }
+
+  /* Queued write then read on one port stay in order */
+  gateway.writeRegister(0, ADD_W1, 40);
+  gateway.readRegister(0, ADD_W1);
+  gateway.requestInfoPackage(0);
+  check(waitFrames(3, 2000), "queued commands complete");
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    check(received.size() == 3 && received[0].cmd == CMD_W && received[1].cmd == CMD_R0 &&
+          received[1].data[6] == 40 &&
+          BM22S4221_1_checkFrame(received[2].data, INFO_PACKAGE_LEN, CMD_U0) == CHECK_OK,
+          "write, read back and info package in submit order");
+    received.clear();
+  }
+  check(gateway.submit(SENSOR_NUM, CMD_R0, ADD_W1, 0x00) != 0, "unknown port rejected");
+
+  /* Commands submitted while stopped are sent after a restart */
+  gateway.end();
+  gateway.readRegister(3, ADD_W1);
+  gateway.readRegister(4, ADD_W1);
+  check(gateway.begin() == 0, "gateway restarts");
+  check(waitFrames(2, 1000), "commands submitted while stopped complete");
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    received.clear();
+  }
+
+  /* A late ack of a timed out read must not complete the next read */
+  gateway.end();
+  emu[5].late = true;
+  gateway.readRegister(5, ADD_W1);
+  gateway.readRegister(5, ADD_W2);
+  gateway.readRegister(5, ADD_W3);
+  gateway.begin();
+  check(waitFrames(5, 3 * ACK_TIMEOUT_MS + 1000), "late acks delivered");
+  {
+    std::lock_guard<std::mutex> guard(frameLock);
+    int timeout = 0;
+    for (size_t i = 0; i < received.size(); i++)
+    {
+      if (received[i].status == TIMEOUT_ERROR)
+      {
+        timeout++;
+      }
+    }
+    check(received.size() == 5 && timeout == 3, "late ack with another address leaves the command pending");
+    received.clear();
+  }
+
+  gateway.end();
+  emuRunning = false;
+  emuThread.join();
+  for (int i = 0; i < SENSOR_NUM; i++)
+  {
+    close(emu[i].fd);
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/*****************************************************************
+  File:             poll_test.cpp
+  Author:           BESTMODULES
+  Description:      Checks BM22S4221_1_PollScheduler backoff, bus budget,
+                    STATUS edges and signal variance on the Arduino stub
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_PollScheduler.h"
+#include  <stdio.h>
+#include  <vector>
+
+#define  SIGNAL_INDEX  9  // Signal field used by the emulated module, 2 bytes
+
+static std::vector<unsigned long> polls;   // millis() of every info package request
+static uint16_t signal = 0x0200;
+
+/* Emulated module: answers info package requests at once */
+static void onWrite(const uint8_t wbuf[], size_t len)
+{
+  uint8_t pkg[INFO_PACKAGE_LEN] = {FRAME_HEADER, INFO_PACKAGE_LEN, FRAME_ID0, FRAME_ID1, CMD_U0};
+
+  if (len != 4 || wbuf[0] != CMD_U0)
+  {
+    return;
+  }
+  polls.push_back(millis());
+  pkg[SIGNAL_INDEX] = signal >> 8;
+  pkg[SIGNAL_INDEX + 1] = signal & 0xff;
+  pkg[INFO_PACKAGE_LEN - 1] = BM22S4221_1_checkCode(pkg, INFO_PACKAGE_LEN - 1);
+  stubReceive(pkg, sizeof(pkg));
+}
+
+/* Run the scheduler for ms, with signal produced by next() before every poll */
+static void run(BM22S4221_1_PollScheduler &sched, unsigned long ms, uint16_t (*next)() = NULL)
+{
+  unsigned long end = stubTime + ms;
+  size_t count = polls.size();
+  while (stubTime < end)
+  {
+    if (next != NULL && polls.size() != count)
+    {
+      signal = next();
+      count = polls.size();
+    }
+    sched.update();
+    stubTime += 5;
+  }
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+  {
+    failures++;
+  }
+}
+
+static uint16_t wrapNoise()
+{
+  return (signal == 0x01FF) ? 0x0200 : 0x01FF; // 1 LSB across the low byte carry
+}
+
+static uint16_t bigSwing()
+{
+  return (signal == 0x0100) ? 0x0300 : 0x0100;
+}
+
+static void setup(BM22S4221_1 &pir, BM22S4221_1_PollScheduler &sched, uint8_t busBudget)
+{
+  stubReset();
+  stubOnWrite = onWrite;
+  polls.clear();
+  signal = 0x0200;
+  pir.begin();
+  sched.begin(200, 8000, busBudget, HIGH);
+}
+
+int main()
+{
+  HardwareSerial serial;
+  BM22S4221_1 pir(5, &serial);
+  BM22S4221_1_PollScheduler sched(&pir);
+  size_t i;
+  bool doubling = true;
+
+  /* Quiet module: interval doubles per poll up to maxInterval */
+  setup(pir, sched, 50);
+  run(sched, 40000);
+  check(sched.getInterval() == 8000, "quiet interval backs off to maxInterval");
+  for (i = 2; i < polls.size() && polls[i] - polls[i - 1] < 8000; i++)
+  {
+    doubling = doubling && (polls[i] - polls[i - 1] == 2 * (polls[i - 1] - polls[i - 2]));
+  }
+  check(polls.size() >= 3 && polls[1] - polls[0] == 480 && doubling, "gaps double from 2 x minInterval");
+
+  /* Bus budget raises the fast interval: 120 ms per poll at 20 % -> 600 ms */
+  setup(pir, sched, 20);
+  stubPinLevel = HIGH;
+  run(sched, 6000);
+  check(sched.getInterval() == 600 && polls.size() >= 10 && polls.size() <= 11, "bus budget limits the fast rate");
+
+  /* STATUS edge pulls the next poll forward to minInterval after the last one */
+  setup(pir, sched, 50);
+  run(sched, 20000);
+  size_t quiet = polls.size();
+  stubPinLevel = HIGH;
+  run(sched, 10);
+  check(polls.size() == quiet + 1 && sched.getInterval() == 240, "STATUS edge polls at once and resets the interval");
+  run(sched, 2000);
+  check(polls.size() >= quiet + 8, "active STATUS keeps the fast rate");
+  stubPinLevel = LOW;
+  run(sched, 3000);
+  check(sched.getInterval() > 240, "backs off once STATUS is released");
+
+  /* Without a signal field changing packages don't count as activity */
+  setup(pir, sched, 50);
+  run(sched, 20000, bigSwing);
+  check(sched.getActivity() == 0 && sched.getInterval() == 8000, "no signal field, only STATUS counts");
+
+  /* 1 LSB noise across a byte carry is not activity */
+  setup(pir, sched, 50);
+  sched.setSignalField(SIGNAL_INDEX, 2);
+  run(sched, 20000, wrapNoise);
+  check(sched.getActivity() < 16 && sched.getInterval() == 8000, "carry noise keeps low variance and backs off");
+
+  /* Large swings keep the fast rate */
+  setup(pir, sched, 50);
+  sched.setSignalField(SIGNAL_INDEX, 2);
+  run(sched, 3000, bigSwing);
+  check(sched.getActivity() >= 16 && sched.getInterval() == 240, "signal variance keeps the fast rate");
+
+  /* Invalid field position disables the signal */
+  setup(pir, sched, 50);
+  sched.setSignalField(23, 2);
+  run(sched, 3000, bigSwing);
+  check(sched.getActivity() == 0, "field past the check code is rejected");
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+/*****************************************************************
+  File:             zones_test.cpp
+  Author:           BESTMODULES
+  Description:      Checks BM22S4221_1_Zones voting, remapping, motion
+                    timing and info package gating on the Arduino stub
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_Zones.h"
+#include  <stdio.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+  {
+    failures++;
+  }
+}
+
+/* Info package with the alarm flag in byte 7, bit 1 */
+static void makePackage(uint8_t pkg[], bool alarm)
+{
+  for (uint8_t i = 0; i < INFO_PACKAGE_LEN; i++)
+  {
+    pkg[i] = 0;
+  }
+  pkg[0] = FRAME_HEADER;
+  pkg[1] = INFO_PACKAGE_LEN;
+  pkg[2] = FRAME_ID0;
+  pkg[3] = FRAME_ID1;
+  pkg[4] = CMD_U0;
+  pkg[7] = alarm ? 0x02 : 0x00;
+  pkg[INFO_PACKAGE_LEN - 1] = BM22S4221_1_checkCode(pkg, INFO_PACKAGE_LEN - 1);
+}
+
+int main()
+{
+  BM22S4221_1_Zones zones;
+  uint8_t pkg[INFO_PACKAGE_LEN];
+  uint8_t i;
+
+  stubReset();
+  /* Sensors 0~3 in zone 0, 4~7 in zone 1 with 2-of-n voting */
+  for (i = 0; i < 8; i++)
+  {
+    zones.mapSensor(i, i / 4);
+  }
+  check(zones.setVotes(1, 2) == 0, "votes set");
+  check(zones.setVotes(1, 0) != 0 && zones.setVotes(ZONE_MAX_ZONES, 1) != 0, "invalid votes rejected");
+  check(zones.mapSensor(ZONE_MAX_SENSORS, 0) != 0 && zones.mapSensor(0, ZONE_MAX_ZONES) != 0, "invalid mapping rejected");
+  check(!zones.isOccupied(0) && zones.getTimeSinceMotion(0) == ZONE_NO_MOTION, "zone without motion");
+
+  /* 1-of-n and k-of-n */
+  stubTime = 100;
+  zones.updateStatus(1, true);
+  zones.updateStatus(5, true);
+  check(zones.isOccupied(0) && zones.getTimeSinceMotion(0) == 0, "single sensor occupies a 1-of-n zone");
+  check(!zones.isOccupied(1) && zones.getActiveCount(1) == 1, "single sensor is rejected by 2-of-n voting");
+  check(zones.getTimeSinceMotion(1) == ZONE_NO_MOTION, "rejected trigger is not motion");
+  zones.updateStatus(5, true);
+  check(zones.getActiveCount(1) == 1, "repeated report is not counted twice");
+  stubTime = 200;
+  zones.updateStatus(6, true);
+  check(zones.isOccupied(1), "second sensor occupies the 2-of-n zone");
+
+  /* Time since motion runs from the moment the zone became vacant */
+  stubTime = 300;
+  zones.updateStatus(1, false);
+  zones.updateStatus(6, false);
+  stubTime = 1300;
+  check(!zones.isOccupied(0) && zones.getTimeSinceMotion(0) == 1000, "zone 0 vacant for 1000 ms");
+  check(!zones.isOccupied(1) && zones.getTimeSinceMotion(1) == 1000, "zone 1 vacant for 1000 ms");
+
+  /* Raising the vote count re-evaluates the zone */
+  zones.updateStatus(2, true);
+  check(zones.isOccupied(0), "zone 0 occupied again");
+  zones.setVotes(0, 2);
+  check(!zones.isOccupied(0), "zone 0 vacant after votes raised");
+  zones.setVotes(0, 1);
+
+  /* An active sensor carries its vote to the new zone */
+  zones.mapSensor(2, 1);
+  check(!zones.isOccupied(0) && zones.getActiveCount(0) == 0, "vote leaves the old zone");
+  check(zones.isOccupied(1) && zones.getActiveCount(1) == 2, "vote joins the new zone");
+  zones.mapSensor(2, ZONE_NONE);
+  check(!zones.isOccupied(1) && zones.getActiveCount(1) == 1, "unmapped sensor loses its vote");
+  zones.updateStatus(2, false);
+  zones.updateStatus(5, false);
+
+  /* Info packages count only once the alarm flag position is set */
+  makePackage(pkg, true);
+  zones.updateInfoPackage(0, pkg);
+  check(!zones.isOccupied(0), "info package ignored without setInfoStatusField()");
+  zones.setInfoStatusField(7, 0x02);
+  pkg[4] = CMD_R0;
+  zones.updateInfoPackage(0, pkg);
+  check(!zones.isOccupied(0), "wrong header ignored");
+  makePackage(pkg, true);
+  pkg[INFO_PACKAGE_LEN - 1]++;
+  zones.updateInfoPackage(0, pkg);
+  check(!zones.isOccupied(0), "wrong check code ignored");
+  makePackage(pkg, true);
+  zones.updateInfoPackage(0, pkg);
+  check(zones.isOccupied(0), "valid alarm package occupies the zone");
+  makePackage(pkg, false);
+  zones.updateInfoPackage(0, pkg);
+  check(!zones.isOccupied(0), "valid quiet package releases the zone");
+  zones.setInfoStatusField(24, 0x01);
+  makePackage(pkg, true);
+  zones.updateInfoPackage(0, pkg);
+  check(!zones.isOccupied(0), "check code byte refused as alarm flag");
+
+  return failures ? 1 : 0;
+}
@@ -4,6 +4,7 @@
   Description:      Communication and operation function with module
   History：
   V1.0.1-- initial version；2022-11-02；Arduino IDE : v1.8.13
+  V1.0.2-- add register access, config snapshot and non-blocking commands；2026-10-19
 ******************************************************************/
 #include  "BM22S4221-1.h"
 
@@ -74,7 +75,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::requestInfoPackage(uint8_t buff[])
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xAc, 0x00, 0x00, 0x54};
   wirteBytes(uniCmd, 4);
   delay(50);
@@ -98,7 +99,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::getFWVer()
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint16_t FWVer=0;
   uint8_t uniCmd[4] = {0xAD, 0x00, 0x00, 0x53};
   uint8_t uniAck[12];
@@ -120,7 +121,7 @@ Others:
 
 uint8_t BM22S4221_1::getProDate(uint8_t buff[])
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xAD, 0x00, 0x00, 0x53};
   uint8_t uniAck[12];
   wirteBytes(uniCmd, 4);
@@ -146,7 +147,7 @@ Others:
 **********************************************************/
 bool BM22S4221_1::isAutoTx()
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xd0, 0x1b,0x00,0x15};
   uint8_t uniAck[8];
   uint8_t state=0;
@@ -173,7 +174,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::getStatusPinActiveMode()
 {  
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xd0, 0x1c,0x00,0x14};
   uint8_t uniAck[8];
   uint8_t ActiveMode=0;
@@ -200,7 +201,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::getVBG()
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xd2, 0x4c,0x00,0xe2};
   uint8_t uniAck[8];
   uint8_t VBG=0;
@@ -345,7 +346,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::restoreDefault()
 {
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xa0, 0x00, 0x00, 0x60};
   uint8_t uniAck[8]={0};
   wirteBytes(uniCmd, 4);
@@ -368,7 +369,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::resetModule()
 { 
-  clear_UART_FIFO();
+  acquireBus();
   uint8_t uniCmd[4] = {0xaf, 0x00, 0x00, 0x51};
   uint8_t uniAck[8];
   wirteBytes(uniCmd, 4);
@@ -395,21 +396,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setAutoTx(uint8_t state)
 {
-  clear_UART_FIFO();
-  uint8_t uniCmd[4] = {0xe0,0x1b,state,0x51};
-  uint8_t uniAck[8]={0};
-  uint16_t a=0xe0 + 0x1b + state;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd,4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
-    {
-      return  0;
-    }
-    else
-    {
-      return  1;
-    }
+  return writeRegister(ADD_W5, state);
 }
 /**********************************************************
 Description: Modify device alarm output level
@@ -422,21 +409,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setStatusPinActiveMode(uint8_t state)
 {
-  clear_UART_FIFO();
-  uint8_t uniCmd[4] = {0xe0, 0x1c, state, 0x51};
-  uint8_t uniAck[8]={0};
-    uint16_t a=0xe0 + 0x1c + state;
-    uniCmd[3] = ~(lowByte(a)) + 1;
-    wirteBytes(uniCmd, 4);
-    delay(100);
-    if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
-    {
-      return  0;
-    }
-    else
-    {
-      return  1;
-    }
+  return writeRegister(ADD_W6, state);
 }
 /**********************************************************
 Description: Modify Internal OPA Gain
@@ -448,21 +421,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setOpaGain(uint8_t value)
 {
-  clear_UART_FIFO();
-  uint8_t uniCmd[4] = {0xe0, 0x05, value, 0x51};
-  uint8_t uniAck[8];
-  uint16_t a=0xe0 + 0x05 + value;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd, 4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
-  {
-    return  0;
-  }
-  else
-  {
-    return  1;
-  }
+  return writeRegister(ADD_W0, value);
 }
 /**********************************************************
 Description: Modify detection deviation value
@@ -474,21 +433,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setAlarmThreshold(uint8_t Threshold)
 {
-  clear_UART_FIFO();
-  uint8_t uniCmd[4] = {0xe0, 0x07, Threshold, 0x51};
-  uint8_t uniAck[8];
-  uint16_t a=0xe0 + 0x07 + Threshold;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd, 4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
-  {
-    return  0;
-  }
-  else
-  {
-    return  1;
-  }
+  return writeRegister(ADD_W1, Threshold);
 }
 /**********************************************************
 Description: Modify alarm detection delay time          
@@ -500,22 +445,7 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setAlarmDetectDelay(uint8_t time)
 {
-  clear_UART_FIFO();
-  time=time * 2;
-  uint8_t uniCmd[4] = {0xe0, 0x08, time, 0x51};
-  uint8_t uniAck[8];
-  uint16_t a=0xe0 + 0x08 + time;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd, 4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0 )
-  {
-    return  0;
-  }
-  else
-  {
-    return  1;
-  }
+  return writeRegister(ADD_W2, time * 2);
 }
 /**********************************************************
 Description: Modify the output time of alarm signal status pin           
@@ -526,16 +456,37 @@ Others:
 **********************************************************/
 uint8_t BM22S4221_1::setAlarmOutputTime(uint8_t time)
 {
-  clear_UART_FIFO();
-  time=time * 2;
-  uint8_t uniCmd[4] = {0xe0, 0x09, time, 0x51};
+  return writeRegister(ADD_W3, time * 2);
+}
+/**********************************************************
+Description: Modify preheating time
+             Change to less than 30s
+Parameters:  time:The setting range is 30~127 and the preheating time is not repairable
+Return:      1: Module setting failed without correct feedback value
+             0: Module set successfully
+Others:
+**********************************************************/
+uint8_t BM22S4221_1::setPreheaTime(uint8_t time)
+{
+  return writeRegister(ADD_W4, time * 2);
+}
+/**********************************************************
+Description: Read a configuration register
+Parameters:  addr: register address, ADD_W0~ADD_W6
+             value: Store the register value
+Return:      1: module data acquisition failed, there is no correct feedback value
+             0: Module data obtained successfully
+Others:
+**********************************************************/
+uint8_t BM22S4221_1::readRegister(uint8_t addr, uint8_t &value)
+{
+  acquireBus();
   uint8_t uniAck[8];
-  uint16_t a=0xe0 + 0x09 + time;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd, 4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
+  writeCommand(CMD_R0, addr, 0x00);
+  delay(90);//TDEL-RSP + read delay
+  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == CMD_R0 && uniAck[5] == addr)
   {
+    value = uniAck[6];
     return  0;
   }
   else
@@ -544,24 +495,20 @@ uint8_t BM22S4221_1::setAlarmOutputTime(uint8_t time)
   }
 }
 /**********************************************************
-Description: Modify preheating time
-             Change to less than 30s
-Parameters:  time:The setting range is 30~127 and the preheating time is not repairable
+Description: Write a configuration register
+Parameters:  addr: register address, ADD_W0~ADD_W6
+             value: raw register value
 Return:      1: Module setting failed without correct feedback value
              0: Module set successfully
 Others:
 **********************************************************/
-uint8_t BM22S4221_1::setPreheaTime(uint8_t time)
+uint8_t BM22S4221_1::writeRegister(uint8_t addr, uint8_t value)
 {
-  clear_UART_FIFO();
-  time=time * 2;
-  uint8_t uniCmd[4] = {0xe0, 0x0c, time, 0x51};
-  uint8_t uniAck[8];
-  uint16_t a=0xe0 + 0x0c + time;
-  uniCmd[3] = ~(lowByte(a)) + 1;
-  wirteBytes(uniCmd, 4);
-  delay(100);
-  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == 0xe0)
+  acquireBus();
+  uint8_t uniAck[8]={0};
+  writeCommand(CMD_W, addr, value);
+  delay(170);//TDEL-RSP + write delay
+  if (readBytes(uniAck,8,10) == 0x00 && uniAck[4] == CMD_W)
   {
     return  0;
   }
@@ -571,6 +518,207 @@ uint8_t BM22S4221_1::setPreheaTime(uint8_t time)
   }
 }
 /**********************************************************
+Description: Read all configuration registers
+             All read commands are sent back to back and the acks are
+             collected afterwards, so the sweep costs one response delay
+             instead of one per register. Acks are matched to registers
+             by address; from the first lost or mismatched ack on, the
+             registers are read again one by one.
+Parameters:  config: Store the raw register values
+Return:      1: module data acquisition failed, there is no correct feedback value
+             0: Module data obtained successfully
+Others:
+**********************************************************/
+uint8_t BM22S4221_1::snapshot(BM22S4221_1_Config &config)
+{
+  const uint8_t *addr = BM22S4221_1_configAddr;
+  uint8_t uniAck[8];
+  uint8_t i, result = 0;
+
+  acquireBus();
+  for (i = 0; i < CONFIG_REG_NUM; i++)
+  {
+    writeCommand(CMD_R0, addr[i], 0x00);
+  }
+  delay(90);
+  for (i = 0; i < CONFIG_REG_NUM; i++)
+  {
+    if (readBytes(uniAck,8,100) == 0x00 && uniAck[4] == CMD_R0 && uniAck[5] == addr[i])
+    {
+      config.value[i] = uniAck[6];
+    }
+    else
+    {
+      break; // Ack lost or out of step from here on
+    }
+  }
+  /* Fall back to single reads for the remaining registers */
+  for (; i < CONFIG_REG_NUM; i++)
+  {
+    result |= readRegister(addr[i], config.value[i]);
+  }
+  return  result;
+}
+/**********************************************************
+Description: Write back a configuration read by snapshot()
+             Only the registers that differ from the module are written.
+             ADD_W5 goes last: enabling AUTO starts unsolicited info
+             packages that would collide with the following acks.
+Parameters:  config: raw register values
+Return:      1: Module setting failed without correct feedback value
+             0: Module set successfully
+Others:      If the current configuration can't be read, all registers are written
+**********************************************************/
+uint8_t BM22S4221_1::restore(const BM22S4221_1_Config &config)
+{
+  const uint8_t *addr = BM22S4221_1_configAddr;
+  const uint8_t order[CONFIG_REG_NUM] = {0, 1, 2, 3, 4, 6, 5}; // ADD_W5 last
+  BM22S4221_1_Config current;
+  uint8_t n, i, result = 0;
+  bool force = (snapshot(current) != 0);
+
+  for (n = 0; n < CONFIG_REG_NUM; n++)
+  {
+    i = order[n];
+    if (force || current.value[i] != config.value[i])
+    {
+      result |= writeRegister(addr[i], config.value[i]);
+    }
+  }
+  return  result;
+}
+/**********************************************************
+Description: Query whether the serial bus is free for a new command
+             The bus is idle when no non-blocking command is waiting
+             for its ack and the receive FIFO is empty.
+Parameters:  none
+Return:      true: bus idle
+             false: bus busy
+Others:      A pending command is dropped after ACK_TIMEOUT_MS. Bytes
+             nobody waits for (late acks, noise, unread AUTO packages)
+             are cleared once they sat in the FIFO for ACK_TIMEOUT_MS.
+**********************************************************/
+bool BM22S4221_1::isBusIdle()
+{
+  if (_txTicket != 0 && (millis() - _txTime) > ACK_TIMEOUT_MS)
+  {
+    _txTicket = 0;
+  }
+  if (_txTicket != 0)
+  {
+    return false;
+  }
+  if (getRxCount() == 0)
+  {
+    _rxStale = false;
+    return true;
+  }
+  if (!_rxStale)
+  {
+    _rxStale = true;
+    _rxTime = millis();
+  }
+  else if ((millis() - _rxTime) > ACK_TIMEOUT_MS)
+  {
+    clear_UART_FIFO();
+    _rxStale = false;
+    return true;
+  }
+  return false;
+}
+/**********************************************************
+Description: Send a command without waiting for the ack
+             Use readAck() afterwards to collect the ack.
+Parameters:  cmd:command code
+             addr:register address
+             data:register data
+Return:      ticket of the command, pass it to readAck()/abortCommand()
+Others:      Check isBusIdle() first, a pending command is waited for
+**********************************************************/
+uint8_t BM22S4221_1::sendCommand(uint8_t cmd, uint8_t addr, uint8_t data)
+{
+  acquireBus();
+  writeCommand(cmd, addr, data);
+  if (++_txSeq == 0)
+  {
+    _txSeq = 1; // 0 means no command
+  }
+  _txTicket = _txSeq;
+  _txTime = millis();
+  return _txTicket;
+}
+/**********************************************************
+Description: Collect the ack of a command sent by sendCommand()
+Parameters:  ticket:returned by sendCommand()
+             buff:Store the ack
+             len:Length of the ack
+Return:      0: check ok
+             1: check error, the receive FIFO is cleared
+             2: command lost, a blocking call or another command took the bus
+             3: ack not complete yet, call again later
+Others:      Never blocks
+**********************************************************/
+uint8_t BM22S4221_1::readAck(uint8_t ticket, uint8_t buff[], uint8_t len)
+{
+  if (ticket == 0 || ticket != _txTicket)
+  {
+    return TIMEOUT_ERROR;
+  }
+  if (getRxCount() < len)
+  {
+    return ACK_PENDING;
+  }
+  _txTicket = 0;
+  uint8_t result = readBytes(buff, len, 0);
+  if (result != CHECK_OK)
+  {
+    clear_UART_FIFO(); // Drop the rest of a misaligned ack
+  }
+  return result;
+}
+/**********************************************************
+Description: Give up waiting for the ack of a command sent by sendCommand()
+Parameters:  ticket:returned by sendCommand()
+Return:      none
+Others:      Does nothing if the bus already belongs to another command
+**********************************************************/
+void BM22S4221_1::abortCommand(uint8_t ticket)
+{
+  if (ticket != 0 && ticket == _txTicket)
+  {
+    _txTicket = 0;
+    clear_UART_FIFO();
+  }
+}
+/**********************************************************
+Description: Take the bus for a new command
+             If a non-blocking command is still waiting for its ack, wait
+             until the ack is complete or ACK_TIMEOUT_MS has passed, so
+             the ack can't be mistaken for the ack of the new command.
+Parameters:  none
+Return:      none
+Others:      The pending command is dropped, readAck() reports it as lost
+**********************************************************/
+void BM22S4221_1::acquireBus()
+{
+  uint8_t num = 0, quietCnt = 0;
+  while (_txTicket != 0 && (millis() - _txTime) <= ACK_TIMEOUT_MS)
+  {
+    delay(1);
+    if (getRxCount() != num)
+    {
+      num = getRxCount();
+      quietCnt = 0;
+    }
+    else if (num > 0 && ++quietCnt > 3)
+    {
+      break; // No new byte for 3 byte times, the ack is complete
+    }
+  }
+  _txTicket = 0;
+  clear_UART_FIFO();
+}
+/**********************************************************
 Description: UART readBytes
 Parameters:  rbuf:Variables for storing Data to be read
              len:Length of data plus command
@@ -665,6 +813,44 @@ void  BM22S4221_1::wirteBytes(uint8_t wbuf[], uint8_t len)
   delay(70);//TDEL-RSP --Response delay time
 }
 /**********************************************************
+Description: Send a 4-byte command frame without waiting for the ack
+Parameters:  cmd:command code
+             addr:register address
+             data:register data
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1::writeCommand(uint8_t cmd, uint8_t addr, uint8_t data)
+{
+  uint8_t uniCmd[4];
+  BM22S4221_1_buildCommand(uniCmd, cmd, addr, data);
+  if (_softSerial != NULL)
+  {
+    _softSerial->write(uniCmd,4);
+  }
+  else
+  {
+    _serial->write(uniCmd,4);
+  }
+}
+/**********************************************************
+Description: Number of bytes in the UART receive FIFO
+Parameters:  none
+Return:      byte count
+Others:
+**********************************************************/
+uint8_t BM22S4221_1::getRxCount()
+{
+  if (_softSerial != NULL)
+  {
+    return _softSerial->available();
+  }
+  else
+  {
+    return _serial->available();
+  }
+}
+/**********************************************************
 Description: eliminate buff data
 Parameters:  none
 Return:      none    
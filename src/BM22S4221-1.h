@@ -4,20 +4,19 @@ Author:           KE,BESTMODULES
 Description:      Define classes and required variables
 History：         
 V1.0.1-- initial version；2022-11-02；Arduino IDE : v1.8.13
+V1.0.2-- add register access, config snapshot and non-blocking commands；2026-10-19
 ******************************************************************/
 
 #ifndef  _BM22S4221_h_
 #define  _BM22S4221_h_
 #include <Arduino.h>
 #include <SoftwareSerial.h>
-#define  UART_BAUD 9600
-#define  AUTO 0x08
-#define  PASSIVE  0x00
-#define  HIGH_LEVEL 0x08
-#define  LOW_LEVEL 0x00
-#define  CHECK_OK        0
-#define  CHECK_ERROR     1
-#define  TIMEOUT_ERROR   2
+#include "BM22S4221-1_Protocol.h"
+
+typedef struct
+{
+  uint8_t value[CONFIG_REG_NUM]; // Raw register values, in ADD_W0~ADD_W6 order
+} BM22S4221_1_Config;
 
 
  class BM22S4221_1
@@ -45,17 +44,35 @@ V1.0.1-- initial version；2022-11-02；Arduino IDE : v1.8.13
     uint8_t setAlarmDetectDelay(uint8_t time=3);
     uint8_t setAlarmOutputTime(uint8_t time=3);
     uint8_t setPreheaTime(uint8_t time);
+
+    uint8_t readRegister(uint8_t addr, uint8_t &value);
+    uint8_t writeRegister(uint8_t addr, uint8_t value);
+    uint8_t snapshot(BM22S4221_1_Config &config);
+    uint8_t restore(const BM22S4221_1_Config &config);
+
+    bool isBusIdle();
+    uint8_t sendCommand(uint8_t cmd, uint8_t addr, uint8_t data);
+    uint8_t readAck(uint8_t ticket, uint8_t buff[], uint8_t len);
+    void abortCommand(uint8_t ticket);
     
     private:
     void clear_UART_FIFO();
     uint8_t readBytes(uint8_t rbuf[], uint8_t len, uint16_t waitTime);
     void wirteBytes(uint8_t wbuf[], uint8_t len);
+    void writeCommand(uint8_t cmd, uint8_t addr, uint8_t data);
+    uint8_t getRxCount();
+    void acquireBus();
     uint8_t _recBuf[25] = {0}; // Array for storing received data
     uint8_t _rxPin;
     uint8_t _txPin;
     uint8_t _statusPin;
     HardwareSerial*_serial =NULL;
     SoftwareSerial *_softSerial =NULL;
+    uint8_t _txTicket = 0;       // Ticket of the command waiting for its ack, 0: none
+    uint8_t _txSeq = 0;          // Last ticket handed out
+    bool _rxStale = false;       // Unrequested bytes are waiting in the FIFO
+    unsigned long _rxTime = 0;   // millis() when they were first seen
+    unsigned long _txTime = 0;   // millis() when the pending command was sent
  };
 
 
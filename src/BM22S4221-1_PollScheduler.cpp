@@ -0,0 +1,212 @@
+/*****************************************************************
+  File:             BM22S4221-1_PollScheduler.cpp
+  Author:           BESTMODULES
+  Description:      Activity adaptive info package polling for PASSIVE mode
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_PollScheduler.h"
+
+/**********************************************************
+Description: Attach the scheduler to a module
+Parameters:  pir: module object, begin() must already be called
+             and the module set to setAutoTx(PASSIVE)
+Return:      none
+Others:
+**********************************************************/
+BM22S4221_1_PollScheduler::BM22S4221_1_PollScheduler(BM22S4221_1 *pir)
+{
+  _pir = pir;
+  _minInterval = POLL_BUS_COST_MS * 2;
+  _maxInterval = 8000;
+  _interval = _minInterval;
+  _activeLevel = HIGH;
+}
+/**********************************************************
+Description: Set the poll rate limits
+Parameters:  minInterval: poll interval during activity, unit ms
+             maxInterval: longest poll interval when quiet, unit ms
+             busBudget: maximum share of bus time spent polling, 1~100 %
+             activeLevel: STATUS pin level during alarm, HIGH/LOW
+Return:      none
+Others:      The fast interval is raised if it would exceed the bus budget
+**********************************************************/
+void BM22S4221_1_PollScheduler::begin(uint16_t minInterval, uint16_t maxInterval, uint8_t busBudget, uint8_t activeLevel)
+{
+  if (busBudget == 0 || busBudget > 100)
+  {
+    busBudget = 100;
+  }
+  uint16_t floorInterval = (uint32_t)POLL_BUS_COST_MS * 100 / busBudget;
+  _minInterval = (minInterval > floorInterval) ? minInterval : floorInterval;
+  _maxInterval = (maxInterval > _minInterval) ? maxInterval : _minInterval;
+  _interval = _minInterval;
+  _activeLevel = activeLevel;
+  _hasSignal = false;
+  _variance = 0;
+  _lastStatus = false;
+  _ticket = 0;
+  _nextTime = millis();
+}
+/**********************************************************
+Description: Set where the signal value sits in the info package
+             Its running variance is the activity measure, without a
+             signal field only the STATUS pin keeps the fast rate.
+Parameters:  index: byte offset in the 25 byte info package, 5~23
+             size: field length, 1 or 2 bytes, MSB first
+Return:      none
+Others:      POLL_SIGNAL_NONE as index disables the signal
+**********************************************************/
+void BM22S4221_1_PollScheduler::setSignalField(uint8_t index, uint8_t size)
+{
+  if (size < 1 || size > 2 || index < 5 || index + size > 24)
+  {
+    index = POLL_SIGNAL_NONE;
+  }
+  _signalIndex = index;
+  _signalSize = size;
+  _hasSignal = false;
+  _variance = 0;
+}
+/**********************************************************
+Description: Set the signal variance that keeps the fast poll rate
+Parameters:  threshold: variance, unit LSB²
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_PollScheduler::setActivityThreshold(uint32_t threshold)
+{
+  _threshold = threshold;
+}
+/**********************************************************
+Description: Run the scheduler, call it from loop()
+             A STATUS pin edge to the active level brings the next poll
+             forward to minInterval after the last one, the earliest the
+             bus budget allows. While the pin is active or the signal
+             variance is above the threshold the module is polled at
+             minInterval, otherwise the interval doubles after every
+             quiet poll up to maxInterval.
+Parameters:  none
+Return:      true: a new info package was received, see readInfoPackage()
+             false: no new package
+Others:      Never blocks on the module
+**********************************************************/
+bool BM22S4221_1_PollScheduler::update()
+{
+  unsigned long now = millis();
+  bool status = (_pir->getSTATUS() == _activeLevel);
+  uint8_t uniAck[25];
+  uint8_t result, i;
+
+  if (status && !_lastStatus)
+  {
+    _interval = _minInterval;
+    if ((long)(_nextTime - (_sentTime + _minInterval)) > 0)
+    {
+      _nextTime = _sentTime + _minInterval;
+    }
+  }
+  _lastStatus = status;
+
+  if (_ticket != 0)
+  {
+    result = _pir->readAck(_ticket, uniAck, 25);
+    if (result == ACK_PENDING)
+    {
+      if ((now - _sentTime) > ACK_TIMEOUT_MS)
+      {
+        _pir->abortCommand(_ticket);
+        _ticket = 0;
+        schedule(status);
+      }
+      return false;
+    }
+    _ticket = 0;
+    if (result != CHECK_OK || uniAck[4] != CMD_U0)
+    {
+      schedule(status);
+      return false;
+    }
+    for (i = 0; i < 25; i++)
+    {
+      _package[i] = uniAck[i];
+    }
+    if (_signalIndex != POLL_SIGNAL_NONE)
+    {
+      /* Decode the signal field and update the running mean and variance (1/8 weight) */
+      int32_t value = 0;
+      uint32_t diff;
+      for (i = 0; i < _signalSize; i++)
+      {
+        value = (value << 8) | uniAck[_signalIndex + i];
+      }
+      if (!_hasSignal)
+      {
+        _mean = value << 4;
+        _hasSignal = true;
+      }
+      diff = (value > (_mean >> 4)) ? (value - (_mean >> 4)) : ((_mean >> 4) - value);
+      _mean += ((value << 4) - _mean) / 8;
+      _variance = _variance - (_variance >> 3) + ((diff * diff) >> 3);
+    }
+    schedule(status || (_hasSignal && _variance >= _threshold));
+    return true;
+  }
+  if ((long)(now - _nextTime) >= 0 && _pir->isBusIdle())
+  {
+    _ticket = _pir->sendCommand(CMD_U0, 0x00, 0x00);
+    _sentTime = now;
+  }
+  return false;
+}
+/**********************************************************
+Description: Read the last info package received by update()
+Parameters:  array[]:25 byte data
+Return:
+Others:
+**********************************************************/
+void BM22S4221_1_PollScheduler::readInfoPackage(uint8_t array[])
+{
+  for (uint8_t i = 0; i < 25; i++)
+  {
+    array[i] = _package[i];
+  }
+}
+/**********************************************************
+Description: Get the current poll interval
+Parameters:  none
+Return:      interval, unit ms
+Others:
+**********************************************************/
+uint16_t BM22S4221_1_PollScheduler::getInterval()
+{
+  return _interval;
+}
+/**********************************************************
+Description: Get the running signal variance
+Parameters:  none
+Return:      variance, unit LSB², 0 without a signal field
+Others:
+**********************************************************/
+uint32_t BM22S4221_1_PollScheduler::getActivity()
+{
+  return _variance;
+}
+/**********************************************************
+Description: Pick the next poll time
+Parameters:  active: true to poll at the fast rate, false to back off
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_PollScheduler::schedule(bool active)
+{
+  if (active)
+  {
+    _interval = _minInterval;
+  }
+  else if (_interval < _maxInterval)
+  {
+    _interval = (_interval > _maxInterval / 2) ? _maxInterval : _interval * 2;
+  }
+  _nextTime = _sentTime + _interval;
+}
@@ -0,0 +1,50 @@
+/*****************************************************************
+File:             BM22S4221-1_PollScheduler.h
+Author:           BESTMODULES
+Description:      Activity adaptive info package polling for PASSIVE mode
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _BM22S4221_PollScheduler_h_
+#define  _BM22S4221_PollScheduler_h_
+#include "BM22S4221-1.h"
+#define  POLL_BUS_COST_MS  120  // Bus time of one poll: 70ms response delay + 50ms package
+#define  POLL_SIGNAL_NONE  0xFF // No signal field configured
+
+
+ class BM22S4221_1_PollScheduler
+ {
+    public:
+    BM22S4221_1_PollScheduler(BM22S4221_1 *pir);
+    void begin(uint16_t minInterval=200, uint16_t maxInterval=8000, uint8_t busBudget=50, uint8_t activeLevel=HIGH);
+    void setSignalField(uint8_t index, uint8_t size=2);
+    void setActivityThreshold(uint32_t threshold);
+    bool update();
+    void readInfoPackage(uint8_t array[]);
+    uint16_t getInterval();
+    uint32_t getActivity();
+
+    private:
+    void schedule(bool active);
+    BM22S4221_1 *_pir;
+    uint16_t _minInterval;
+    uint16_t _maxInterval;
+    uint16_t _interval;              // Current poll interval, unit ms
+    uint32_t _threshold = 16;        // Signal variance that keeps the fast rate
+    uint8_t _signalIndex = POLL_SIGNAL_NONE; // Info package offset of the signal field
+    uint8_t _signalSize = 2;         // Signal field length, 1 or 2 bytes, MSB first
+    bool _hasSignal = false;
+    int32_t _mean = 0;               // Running signal mean, unit 1/16 LSB
+    uint32_t _variance = 0;          // Running signal variance, unit LSB²
+    uint8_t _activeLevel;
+    bool _lastStatus = false;
+    uint8_t _ticket = 0;             // Ticket of the request waiting for its ack
+    unsigned long _sentTime = 0;     // millis() of the last request
+    unsigned long _nextTime = 0;     // millis() of the next request
+    uint8_t _package[25] = {0};      // Last valid info package
+ };
+
+
+ 
+#endif
@@ -0,0 +1,118 @@
+/*****************************************************************
+File:             BM22S4221-1_Protocol.h
+Author:           BESTMODULES
+Description:      UART protocol constants and frame helpers, without
+                  Arduino dependencies so host backends can share them
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _BM22S4221_Protocol_h_
+#define  _BM22S4221_Protocol_h_
+#include <stdint.h>
+#define  UART_BAUD 9600
+#define  AUTO 0x08
+#define  PASSIVE  0x00
+#define  HIGH_LEVEL 0x08
+#define  LOW_LEVEL 0x00
+#define  CHECK_OK        0
+#define  CHECK_ERROR     1
+#define  TIMEOUT_ERROR   2
+#define  ACK_PENDING     3
+#define  FRAME_HEADER    0xAA
+#define  FRAME_ID0       0x31 // Fixed bytes 2 and 3 of every module frame
+#define  FRAME_ID1       0x01
+#define  INFO_PACKAGE_LEN 25
+#define  FRAME_MAX_LEN   25   // Longest frame sent by the module (info package)
+#define  ACK_TIMEOUT_MS  200  // Longest wait for the ack of a non-blocking command
+
+#define  CMD_U0  0xAC     // Request info package
+#define  CMD_U1  0xAD     // Query FW version and production date
+#define  CMD_R0  0xD0     // Read configuration register
+#define  CMD_R2  0xD2     // Read internal data
+#define  CMD_W   0xE0     // Write configuration register
+#define  ADD_R0  0x4C     // VBG a/d value
+#define  ADD_W0  0x05     // Internal OPA gain
+#define  ADD_W1  0x07     // Alarm threshold (detection deviation)
+#define  ADD_W2  0x08     // Alarm detection delay, n x 0.5s
+#define  ADD_W3  0x09     // Alarm output time, n x 0.5s
+#define  ADD_W4  0x0C     // Preheating time, n x 0.5s
+#define  ADD_W5  0x1B     // Serial port automatic output
+#define  ADD_W6  0x1C     // STATUS pin active level
+#define  CONFIG_REG_NUM  7
+#define  VBG_MIN  32      // Smaller VBG values (VDD > 10V) are read errors
+
+/* Configuration registers in snapshot order */
+static const uint8_t BM22S4221_1_configAddr[CONFIG_REG_NUM] = {ADD_W0, ADD_W1, ADD_W2, ADD_W3, ADD_W4, ADD_W5, ADD_W6};
+
+/**********************************************************
+Description: Calculate the check code of a frame
+Parameters:  buf:frame data
+             len:number of bytes covered by the check code
+Return:      two's complement of the byte sum
+Others:
+**********************************************************/
+static inline uint8_t BM22S4221_1_checkCode(const uint8_t buf[], uint8_t len)
+{
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < len; i++)
+  {
+    sum += buf[i];
+  }
+  return (uint8_t)(~sum + 1);
+}
+/**********************************************************
+Description: Build a 4-byte command frame
+Parameters:  frame:Store the command frame
+             cmd:command code
+             addr:register address
+             data:register data
+Return:      none
+Others:
+**********************************************************/
+static inline void BM22S4221_1_buildCommand(uint8_t frame[4], uint8_t cmd, uint8_t addr, uint8_t data)
+{
+  frame[0] = cmd;
+  frame[1] = addr;
+  frame[2] = data;
+  frame[3] = BM22S4221_1_checkCode(frame, 3);
+}
+/**********************************************************
+Description: Check a frame sent by the module
+Parameters:  buf:frame data
+             len:expected frame length, 8 for register acks,
+                 INFO_PACKAGE_LEN for info packages
+             cmd:command code the frame answers
+Return:      0: check ok
+             1: check error
+Others:
+**********************************************************/
+static inline uint8_t BM22S4221_1_checkFrame(const uint8_t buf[], uint8_t len, uint8_t cmd)
+{
+  if (buf[0] != FRAME_HEADER || buf[1] != len || buf[2] != FRAME_ID0 || buf[3] != FRAME_ID1 ||
+      buf[4] != cmd || BM22S4221_1_checkCode(buf, len - 1) != buf[len - 1])
+  {
+    return CHECK_ERROR;
+  }
+  return CHECK_OK;
+}
+/**********************************************************
+Description: Convert the VBG a/d value to the supply voltage
+             1.25V/VDD×256=VBG a/d value, so VDD(mV) = 320000 / VBG
+Parameters:  vbg:VBG a/d value, see getVBG()
+Return:      0: implausible value (below VBG_MIN)
+             data:supply voltage, unit mV
+Others:
+**********************************************************/
+static inline uint16_t BM22S4221_1_vbgToMv(uint8_t vbg)
+{
+  if (vbg < VBG_MIN)
+  {
+    return 0;
+  }
+  return (uint16_t)((320000UL + vbg / 2) / vbg);
+}
+
+
+ 
+#endif
@@ -0,0 +1,199 @@
+/*****************************************************************
+  File:             BM22S4221-1_SupplyMonitor.cpp
+  Author:           BESTMODULES
+  Description:      Background supply voltage monitor based on the VBG a/d value
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_SupplyMonitor.h"
+
+/**********************************************************
+Description: Attach the monitor to a module
+Parameters:  pir: module object, begin() must already be called
+Return:      none
+Others:
+**********************************************************/
+BM22S4221_1_SupplyMonitor::BM22S4221_1_SupplyMonitor(BM22S4221_1 *pir)
+{
+  _pir = pir;
+  _brownoutMv = 2700;
+  _droopMv = 200;
+  _interval = 1000;
+}
+/**********************************************************
+Description: Set the thresholds and the sample interval
+Parameters:  brownoutMv: brownout threshold, unit mV
+             droopMv: allowed drop of the trend below its maximum, unit mV
+             interval: minimum time between two VBG samples, unit ms
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_SupplyMonitor::begin(uint16_t brownoutMv, uint16_t droopMv, uint16_t interval)
+{
+  _brownoutMv = brownoutMv;
+  _droopMv = droopMv;
+  _interval = interval;
+  _ticket = 0;
+  _brownout = false;
+  _droop = false;
+  _mv = 0;
+  _decSum = 0;
+  _decCnt = 0;
+  _trendHead = 0;
+  _trendCnt = 0;
+  _lastTime = millis() - interval;
+}
+/**********************************************************
+Description: Run the monitor, call it from loop()
+             A VBG request is only sent when the bus is idle, and the
+             ack is collected on a later call, so update() never waits
+             for the module.
+Parameters:  none
+Return:      SUPPLY_EVT_xxx flags raised by this call
+Others:
+**********************************************************/
+uint8_t BM22S4221_1_SupplyMonitor::update()
+{
+  uint8_t uniAck[8];
+  uint8_t result;
+  unsigned long now = millis();
+
+  if (_ticket != 0)
+  {
+    result = _pir->readAck(_ticket, uniAck, 8);
+    if (result == ACK_PENDING)
+    {
+      if ((now - _lastTime) > ACK_TIMEOUT_MS)
+      {
+        _pir->abortCommand(_ticket);
+        _ticket = 0;
+      }
+      return SUPPLY_EVT_NONE;
+    }
+    _ticket = 0;
+    if (result != CHECK_OK || BM22S4221_1_checkFrame(uniAck, 8, CMD_R2) != CHECK_OK || uniAck[5] != ADD_R0)
+    {
+      return SUPPLY_EVT_NONE;
+    }
+    uint16_t mv = BM22S4221_1_vbgToMv(uniAck[6]);
+    if (mv == 0)
+    {
+      return SUPPLY_EVT_NONE;
+    }
+    uint8_t events = SUPPLY_EVT_SAMPLE;
+    bool wasFault = _brownout || _droop;
+
+    _mv = mv;
+    if (!_brownout && mv < _brownoutMv)
+    {
+      _brownout = true;
+      events |= SUPPLY_EVT_BROWNOUT;
+    }
+    else if (_brownout && mv >= _brownoutMv + SUPPLY_HYSTERESIS_MV)
+    {
+      _brownout = false;
+    }
+    bool wasDroop = _droop;
+    addSample(mv);
+    if (!wasDroop && _droop)
+    {
+      events |= SUPPLY_EVT_DROOP;
+    }
+    if (wasFault && !_brownout && !_droop)
+    {
+      events |= SUPPLY_EVT_RECOVERED;
+    }
+    return events;
+  }
+  if ((now - _lastTime) >= _interval && _pir->isBusIdle())
+  {
+    _ticket = _pir->sendCommand(CMD_R2, ADD_R0, 0x00);
+    _lastTime = now;
+  }
+  return SUPPLY_EVT_NONE;
+}
+/**********************************************************
+Description: Get the last supply voltage
+Parameters:  none
+Return:      0: no sample yet
+             data: supply voltage, unit mV
+Others:
+**********************************************************/
+uint16_t BM22S4221_1_SupplyMonitor::getSupplyVoltage()
+{
+  return _mv;
+}
+/**********************************************************
+Description: Get the decimated supply voltage trend
+Parameters:  buff: SUPPLY_TREND_LEN words, oldest point first, unit mV
+Return:      number of valid trend points
+Others:
+**********************************************************/
+uint8_t BM22S4221_1_SupplyMonitor::getTrend(uint16_t buff[])
+{
+  uint8_t start = (_trendHead + SUPPLY_TREND_LEN - _trendCnt) % SUPPLY_TREND_LEN;
+  for (uint8_t i = 0; i < _trendCnt; i++)
+  {
+    buff[i] = _trend[(start + i) % SUPPLY_TREND_LEN];
+  }
+  return _trendCnt;
+}
+/**********************************************************
+Description: Query whether the supply is below the brownout threshold
+Parameters:  none
+Return:      true: brownout
+             false: supply normal
+Others:
+**********************************************************/
+bool BM22S4221_1_SupplyMonitor::isBrownout()
+{
+  return _brownout;
+}
+/**********************************************************
+Description: Query whether the supply trend is drooping
+Parameters:  none
+Return:      true: latest trend point is more than droopMv below the trend maximum
+             false: trend normal
+Others:
+**********************************************************/
+bool BM22S4221_1_SupplyMonitor::isDroop()
+{
+  return _droop;
+}
+/**********************************************************
+Description: Feed one sample into the decimation filter
+             Every SUPPLY_DECIMATION samples one averaged point is pushed
+             to the trend and the droop condition is re-evaluated.
+Parameters:  mv: supply voltage, unit mV
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_SupplyMonitor::addSample(uint16_t mv)
+{
+  uint16_t point, maxPoint;
+  uint8_t i;
+
+  _decSum += mv;
+  if (++_decCnt < SUPPLY_DECIMATION)
+  {
+    return;
+  }
+  point = (_decSum + SUPPLY_DECIMATION / 2) / SUPPLY_DECIMATION;
+  _decSum = 0;
+  _decCnt = 0;
+
+  _trend[_trendHead] = point;
+  _trendHead = (_trendHead + 1) % SUPPLY_TREND_LEN;
+  if (_trendCnt < SUPPLY_TREND_LEN)
+  {
+    _trendCnt++;
+  }
+  for (i = 0, maxPoint = 0; i < _trendCnt; i++)
+  {
+    if (_trend[i] > maxPoint)
+    {
+      maxPoint = _trend[i];
+    }
+  }
+  _droop = (maxPoint - point) > _droopMv;
+}
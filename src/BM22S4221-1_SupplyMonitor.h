@@ -0,0 +1,53 @@
+/*****************************************************************
+File:             BM22S4221-1_SupplyMonitor.h
+Author:           BESTMODULES
+Description:      Background supply voltage monitor based on the VBG a/d value
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _BM22S4221_SupplyMonitor_h_
+#define  _BM22S4221_SupplyMonitor_h_
+#include "BM22S4221-1.h"
+#define  SUPPLY_DECIMATION     8    // VBG samples averaged into one trend point
+#define  SUPPLY_TREND_LEN      8    // Trend points kept
+#define  SUPPLY_HYSTERESIS_MV  50   // Recovery margin above the brownout threshold
+#define  SUPPLY_EVT_NONE       0x00
+#define  SUPPLY_EVT_SAMPLE     0x01 // New supply voltage sample
+#define  SUPPLY_EVT_BROWNOUT   0x02 // Supply fell below the brownout threshold
+#define  SUPPLY_EVT_DROOP      0x04 // Trend fell by more than the droop threshold
+#define  SUPPLY_EVT_RECOVERED  0x08 // Brownout and droop conditions cleared
+
+
+ class BM22S4221_1_SupplyMonitor
+ {
+    public:
+    BM22S4221_1_SupplyMonitor(BM22S4221_1 *pir);
+    void begin(uint16_t brownoutMv=2700, uint16_t droopMv=200, uint16_t interval=1000);
+    uint8_t update();
+    uint16_t getSupplyVoltage();
+    uint8_t getTrend(uint16_t buff[]);
+    bool isBrownout();
+    bool isDroop();
+
+    private:
+    void addSample(uint16_t mv);
+    BM22S4221_1 *_pir;
+    uint16_t _brownoutMv;
+    uint16_t _droopMv;
+    uint16_t _interval;
+    unsigned long _lastTime = 0;    // millis() of the last VBG request
+    uint8_t _ticket = 0;            // Ticket of the VBG request waiting for its ack
+    bool _brownout = false;
+    bool _droop = false;
+    uint16_t _mv = 0;               // Last supply voltage, unit mV
+    uint32_t _decSum = 0;           // Sum of samples in the current decimation window
+    uint8_t _decCnt = 0;
+    uint16_t _trend[SUPPLY_TREND_LEN] = {0}; // Ring buffer of decimated samples
+    uint8_t _trendHead = 0;         // Next slot to write
+    uint8_t _trendCnt = 0;
+ };
+
+
+ 
+#endif
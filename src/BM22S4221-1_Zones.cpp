@@ -0,0 +1,239 @@
+/*****************************************************************
+  File:             BM22S4221-1_Zones.cpp
+  Author:           BESTMODULES
+  Description:      Zone occupancy aggregation over many modules
+  History：
+  V1.0.2-- initial version；2026-10-19
+******************************************************************/
+#include  "BM22S4221-1_Zones.h"
+
+#if ZONE_MAX_SENSORS > 255 || ZONE_MAX_ZONES > 254
+#error "Zone and sensor indexes are uint8_t"
+#endif
+#define  BIT_GET(set, n)  (((set)[(n) >> 3] >> ((n) & 7)) & 1)
+#define  BIT_SET(set, n)  ((set)[(n) >> 3] |= (1 << ((n) & 7)))
+#define  BIT_CLR(set, n)  ((set)[(n) >> 3] &= ~(1 << ((n) & 7)))
+
+/**********************************************************
+Description: Create an empty zone map, no sensor is mapped
+Parameters:  none
+Return:      none
+Others:
+**********************************************************/
+BM22S4221_1_Zones::BM22S4221_1_Zones()
+{
+  uint16_t i;
+  for (i = 0; i < ZONE_MAX_SENSORS; i++)
+  {
+    _zoneOf[i] = ZONE_NONE;
+  }
+  for (i = 0; i < sizeof(_sensorActive); i++)
+  {
+    _sensorActive[i] = 0;
+  }
+  for (i = 0; i < sizeof(_zoneOccupied); i++)
+  {
+    _zoneOccupied[i] = 0;
+    _zoneSeen[i] = 0;
+  }
+  for (i = 0; i < ZONE_MAX_ZONES; i++)
+  {
+    _activeCnt[i] = 0;
+    _votes[i] = 1;
+    _lastMotion[i] = 0;
+  }
+  _statusIndex = INFO_STATUS_NONE;
+  _statusMask = 0;
+}
+/**********************************************************
+Description: Assign a sensor to a zone
+Parameters:  sensor: sensor index, 0~ZONE_MAX_SENSORS-1
+             zone: zone index, 0~ZONE_MAX_ZONES-1, ZONE_NONE to unmap
+Return:      1: index out of range
+             0: mapped successfully
+Others:      An active sensor moves its vote to the new zone
+**********************************************************/
+uint8_t BM22S4221_1_Zones::mapSensor(uint8_t sensor, uint8_t zone)
+{
+  if (sensor >= ZONE_MAX_SENSORS || (zone >= ZONE_MAX_ZONES && zone != ZONE_NONE))
+  {
+    return 1;
+  }
+  uint8_t old = _zoneOf[sensor];
+  unsigned long now = millis();
+  _zoneOf[sensor] = zone;
+  if (BIT_GET(_sensorActive, sensor))
+  {
+    if (old != ZONE_NONE)
+    {
+      _activeCnt[old]--;
+      refreshZone(old, now);
+    }
+    if (zone != ZONE_NONE)
+    {
+      _activeCnt[zone]++;
+      refreshZone(zone, now);
+    }
+  }
+  return 0;
+}
+/**********************************************************
+Description: Set k-of-n voting for a zone
+             The zone is occupied when at least votes sensors report motion,
+             so a single false trigger can be rejected with votes=2.
+Parameters:  zone: zone index
+             votes: active sensors needed, 1(default)~255
+Return:      1: parameter out of range
+             0: set successfully
+Others:
+**********************************************************/
+uint8_t BM22S4221_1_Zones::setVotes(uint8_t zone, uint8_t votes)
+{
+  if (zone >= ZONE_MAX_ZONES || votes == 0)
+  {
+    return 1;
+  }
+  _votes[zone] = votes;
+  refreshZone(zone, millis());
+  return 0;
+}
+/**********************************************************
+Description: Set where updateInfoPackage() finds the alarm flag
+             There is no default, info packages are ignored until the
+             position is set from the module's package layout.
+Parameters:  index: byte offset in the 25 byte info package, 5~23
+             mask: bits of that byte that mean alarm
+Return:      none
+Others:      INFO_STATUS_NONE as index ignores info packages again
+**********************************************************/
+void BM22S4221_1_Zones::setInfoStatusField(uint8_t index, uint8_t mask)
+{
+  if (index < 5 || index > 23 || mask == 0)
+  {
+    index = INFO_STATUS_NONE;
+  }
+  _statusIndex = index;
+  _statusMask = mask;
+}
+/**********************************************************
+Description: Report the alarm state of a sensor
+             Only state changes touch the zone, so the cost does not
+             depend on the number of sensors.
+Parameters:  sensor: sensor index
+             active: true when the sensor reports motion,
+                     e.g. getSTATUS() equal to its active level
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Zones::updateStatus(uint8_t sensor, bool active)
+{
+  if (sensor >= ZONE_MAX_SENSORS || active == (bool)BIT_GET(_sensorActive, sensor))
+  {
+    return;
+  }
+  uint8_t zone = _zoneOf[sensor];
+  unsigned long now = millis();
+  if (active)
+  {
+    BIT_SET(_sensorActive, sensor);
+  }
+  else
+  {
+    BIT_CLR(_sensorActive, sensor);
+  }
+  if (zone == ZONE_NONE)
+  {
+    return;
+  }
+  if (active)
+  {
+    _activeCnt[zone]++;
+  }
+  else
+  {
+    _activeCnt[zone]--;
+  }
+  refreshZone(zone, now);
+}
+/**********************************************************
+Description: Report the alarm state of a sensor from its info package
+Parameters:  sensor: sensor index
+             array[]: 25 byte info package, see readInfoPackage()
+Return:      none
+Others:      Does nothing until setInfoStatusField() is called, or if
+             the package header or check code is wrong
+**********************************************************/
+void BM22S4221_1_Zones::updateInfoPackage(uint8_t sensor, uint8_t array[])
+{
+  if (_statusIndex == INFO_STATUS_NONE ||
+      BM22S4221_1_checkFrame(array, INFO_PACKAGE_LEN, CMD_U0) != CHECK_OK)
+  {
+    return;
+  }
+  updateStatus(sensor, (array[_statusIndex] & _statusMask) != 0);
+}
+/**********************************************************
+Description: Query whether a zone is occupied
+Parameters:  zone: zone index
+Return:      true: occupied
+             false: vacant
+Others:
+**********************************************************/
+bool BM22S4221_1_Zones::isOccupied(uint8_t zone)
+{
+  return (zone < ZONE_MAX_ZONES) && BIT_GET(_zoneOccupied, zone);
+}
+/**********************************************************
+Description: Get the number of sensors reporting motion in a zone
+Parameters:  zone: zone index
+Return:      active sensor count
+Others:
+**********************************************************/
+uint8_t BM22S4221_1_Zones::getActiveCount(uint8_t zone)
+{
+  return (zone < ZONE_MAX_ZONES) ? _activeCnt[zone] : 0;
+}
+/**********************************************************
+Description: Get the time since the last motion in a zone
+Parameters:  zone: zone index
+Return:      0: zone occupied
+             ZONE_NO_MOTION: zone never saw motion
+             data: time since the zone became vacant, unit ms
+Others:
+**********************************************************/
+unsigned long BM22S4221_1_Zones::getTimeSinceMotion(uint8_t zone)
+{
+  if (zone >= ZONE_MAX_ZONES || !BIT_GET(_zoneSeen, zone))
+  {
+    return ZONE_NO_MOTION;
+  }
+  if (BIT_GET(_zoneOccupied, zone))
+  {
+    return 0;
+  }
+  return millis() - _lastMotion[zone];
+}
+/**********************************************************
+Description: Re-evaluate the occupancy bit of a zone
+Parameters:  zone: zone index
+             now: current millis()
+Return:      none
+Others:
+**********************************************************/
+void BM22S4221_1_Zones::refreshZone(uint8_t zone, unsigned long now)
+{
+  if (_activeCnt[zone] >= _votes[zone])
+  {
+    BIT_SET(_zoneOccupied, zone);
+    BIT_SET(_zoneSeen, zone);
+    _lastMotion[zone] = now;
+  }
+  else
+  {
+    if (BIT_GET(_zoneOccupied, zone))
+    {
+      _lastMotion[zone] = now; // Motion lasted until the zone became vacant
+    }
+    BIT_CLR(_zoneOccupied, zone);
+  }
+}
@@ -0,0 +1,47 @@
+/*****************************************************************
+File:             BM22S4221-1_Zones.h
+Author:           BESTMODULES
+Description:      Zone occupancy aggregation over many modules
+History：         
+V1.0.2-- initial version；2026-10-19
+******************************************************************/
+
+#ifndef  _BM22S4221_Zones_h_
+#define  _BM22S4221_Zones_h_
+#include "BM22S4221-1.h"
+#define  ZONE_MAX_SENSORS   64          // Sensor index is uint8_t, at most 255
+#define  ZONE_MAX_ZONES     16          // Zone index is uint8_t, at most 254
+#define  ZONE_NONE          0xFF        // Sensor not mapped to a zone
+#define  ZONE_NO_MOTION     0xFFFFFFFF  // Zone never saw motion
+#define  INFO_STATUS_NONE   0xFF        // Alarm flag position not set
+
+
+ class BM22S4221_1_Zones
+ {
+    public:
+    BM22S4221_1_Zones();
+    uint8_t mapSensor(uint8_t sensor, uint8_t zone);
+    uint8_t setVotes(uint8_t zone, uint8_t votes=1);
+    void setInfoStatusField(uint8_t index, uint8_t mask);
+    void updateStatus(uint8_t sensor, bool active);
+    void updateInfoPackage(uint8_t sensor, uint8_t array[]);
+    bool isOccupied(uint8_t zone);
+    uint8_t getActiveCount(uint8_t zone);
+    unsigned long getTimeSinceMotion(uint8_t zone);
+
+    private:
+    void refreshZone(uint8_t zone, unsigned long now);
+    uint8_t _zoneOf[ZONE_MAX_SENSORS];                  // Zone of each sensor
+    uint8_t _sensorActive[(ZONE_MAX_SENSORS + 7) / 8];  // Bitset, sensor reports motion
+    uint8_t _zoneOccupied[(ZONE_MAX_ZONES + 7) / 8];    // Bitset, zone occupied
+    uint8_t _zoneSeen[(ZONE_MAX_ZONES + 7) / 8];        // Bitset, zone saw motion at least once
+    uint8_t _activeCnt[ZONE_MAX_ZONES];                 // Active sensors per zone
+    uint8_t _votes[ZONE_MAX_ZONES];                     // Active sensors needed for occupancy
+    unsigned long _lastMotion[ZONE_MAX_ZONES];          // millis() of the last motion
+    uint8_t _statusIndex;
+    uint8_t _statusMask;
+ };
+
+
+ 
+#endif